@@ -1,4 +1,5 @@
 #include <mpi.h>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
@@ -6,24 +7,33 @@
 class EvalPoint
 {
 private:
+    uint64_t _id;
     double  _x;
-    int     _f;
+    double  _f;
     bool    _evalOk;
+    bool    _aborted;   // Evaluation stopped early: f is only a lower bound.
+    bool    _feasible;  // All constraints are satisfied.
     int     _workerRank;
 
 public:
     // Constructor
-    EvalPoint(double x, double f, bool evalOk, int workerRank)
-      : _x(x),
+    EvalPoint(uint64_t id, double x, double f, bool evalOk, bool aborted, bool feasible, int workerRank)
+      : _id(id),
+        _x(x),
         _f(f),
         _evalOk(evalOk),
+        _aborted(aborted),
+        _feasible(feasible),
         _workerRank(workerRank)
     {}
 
     // Get/Set
+    uint64_t getId()    { return _id; }
     double getX()       { return _x; }
-    int    getF()       { return _f; }
-    double getEvalOk()  { return _evalOk; }
+    double getF()       { return _f; }
+    bool   getEvalOk()  { return _evalOk; }
+    bool   getAborted() { return _aborted; }
+    bool   getFeasible(){ return _feasible; }
     int    getWorker()  { return _workerRank; }
 };
 
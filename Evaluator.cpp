@@ -1,7 +1,7 @@
-
 #include "Evaluator.hpp"
 
-bool Evaluator::eval_x(const double x, double &f)
+bool Evaluator::eval_x(const double x, const std::atomic<double> &threshold,
+                       double &f, std::vector<double> &c, bool &aborted)
 {
     // Debug
     /*
@@ -14,11 +14,33 @@ bool Evaluator::eval_x(const double x, double &f)
     */
 
     bool eval_ok = false;
+    aborted = false;
+
+    // Constraint: x <= 90.
+    // It is known before f is computed, so an infeasible point stops here.
+    c.assign(nbConstraints, 0.0);
+    c[0] = x - 90.0;
+    f = 0.0;
+    if (c[0] > 0.0)
+    {
+        aborted = true;
+        return true;
+    }
 
-    f = static_cast<int> (x);
+    // Mock a long simulation: f is accumulated in steps, and can only
+    // increase. Stop as soon as f is above threshold.
+    int nbSteps = static_cast<int> (x);
+    for (int step = 0; step < nbSteps; step++)
+    {
+        f += 1.0;
+        if (f > threshold.load())
+        {
+            aborted = true;
+            break;
+        }
+    }
     eval_ok = true;
 
     return eval_ok;
 }
 
-
@@ -1,8 +1,13 @@
 #include <mpi.h>
+#include <atomic>
 #include <iostream>
 #include <vector>
 
 
+// Number of constraints of the problem.
+// A point is feasible if all its constraint values are <= 0.
+const int nbConstraints = 1;
+
 class Evaluator
 {
 public:
@@ -10,9 +15,16 @@ public:
 
     // Mock evaluator.
     // Input: x.
-    // Output: f.
+    // Input: threshold: the evaluation may stop early as soon as it is known
+    //        that f will be above threshold, or that x is infeasible.
+    //        It is checked periodically during the evaluation, and may be
+    //        updated by another thread meanwhile.
+    // Output: f, and c, the nbConstraints constraint values.
+    //         If the evaluation stopped early, f is a lower bound of the value
+    //         that a full evaluation would give.
+    // Output: aborted: true if the evaluation stopped early.
     // Returns: true if eval went OK, false otherwise.
-    bool eval_x(const double x, double &f);
+    bool eval_x(const double x, const std::atomic<double> &threshold,
+                double &f, std::vector<double> &c, bool &aborted);
 };
 
-
@@ -11,31 +11,160 @@ void EvaluatorControl::run()
     MPI_Get_processor_name(processorName, &nameLen);
 
 
-    std::cout << "VRM: run EvaluatorControl for rank " << workerRank << std::endl;
+    if (_verbose)
+    {
+        std::cout << "VRM: run EvaluatorControl for rank " << workerRank << " with " << _nbThreads << " thread(s)" << std::endl;
+    }
 
     // Start workers
-    // Workers get a point, evaluate it, and return its evaluation.
+    // Workers get points, evaluate them, and return their evaluations.
     if (0 != workerRank)
     {
+        std::vector<std::thread> evaluatorThreads;
+        if (_nbThreads > 1)
+        {
+            for (int i = 0; i < _nbThreads; i++)
+            {
+                evaluatorThreads.push_back(std::thread(&EvaluatorControl::evaluatorThreadRun, this));
+            }
+        }
+
         bool evaluationDone = false;
         while (!evaluationDone)
         {
-            double x = 0.0;
-            double f = 0.0;
-            if (getNewPointToEvaluate(x))
+            // With 1 thread, a new threshold is also received between the
+            // points of a message, but is not seen by the evaluation in
+            // progress. With more threads, it is also seen by evaluations in
+            // progress.
+            receiveThreshold();
+
+            std::vector<PointMessage> pointVector;
+            if (getNewPointsToEvaluate(pointVector))
+            {
+                if (_nbThreads > 1)
+                {
+                    std::lock_guard<std::mutex> lock(_queueMutex);
+                    _pointQueue.insert(_pointQueue.end(), pointVector.begin(), pointVector.end());
+                    _pointQueueCond.notify_all();
+                }
+                else
+                {
+                    if (_verbose)
+                    {
+                        std::cout << "VRM: EvaluatorControl calls eval_x for rank " << workerRank << " on host " << processorName << std::endl;
+                    }
+                    // Send each result as soon as it is computed, so that
+                    // master hears from this worker after every evaluation.
+                    for (size_t i = 0; i < pointVector.size(); i++)
+                    {
+                        if (i > 0)
+                        {
+                            receiveThreshold();
+                        }
+                        std::vector<ResultMessage> resultVector(1, evaluate(_evaluator, pointVector[i]));
+                        sendPointsToMaster(resultVector);
+                    }
+                }
+            }
+
+            if (_nbThreads > 1)
             {
-                std::cout << "VRM: EvaluatorControl calls eval_x for rank " << workerRank << " on host " << processorName << std::endl;
-                bool eval_ok = _evaluator.eval_x(x, f);
-                sendPointToMaster(x, f, eval_ok);
+                // Send all results available, in aggregate.
+                // If there are none, wait a little for evaluator threads, so
+                // that this thread does not take a core away from them.
+                std::vector<ResultMessage> resultVector;
+                {
+                    std::unique_lock<std::mutex> lock(_queueMutex);
+                    if (_resultVector.empty())
+                    {
+                        _resultCond.wait_for(lock, std::chrono::duration<double>(resultWaitTimeout));
+                    }
+                    resultVector.swap(_resultVector);
+                }
+                sendPointsToMaster(resultVector);
             }
             evaluationDone = isEvaluationDone();
         }
+        // Master may have sent a threshold just before the word that it is done.
+        receiveThreshold();
+
+        // Stop evaluator threads.
+        {
+            std::lock_guard<std::mutex> lock(_queueMutex);
+            _stopThreads = true;
+            _pointQueueCond.notify_all();
+        }
+        for (size_t i = 0; i < evaluatorThreads.size(); i++)
+        {
+            evaluatorThreads[i].join();
+        }
     }
     // Send word that the worker is done.
     sendWorkerDoneToMaster();
 }
 
-bool EvaluatorControl::getNewPointToEvaluate(double &x)
+ResultMessage EvaluatorControl::evaluate(Evaluator &evaluator, const PointMessage &point)
+{
+    double f = 0.0;
+    std::vector<double> c;
+    bool aborted = false;
+    bool eval_ok = evaluator.eval_x(point.x, _threshold, f, c, aborted);
+
+    // Value-initialize, so that the padding bytes sent as MPI_BYTE are zero.
+    ResultMessage result = {};
+    result.id = point.id;
+    result.f = f;
+    for (int i = 0; i < nbConstraints; i++)
+    {
+        result.c[i] = (i < (int)c.size()) ? c[i] : 0.0;
+    }
+    result.status = 0;
+    if (eval_ok)
+    {
+        result.status |= statusEvalOk;
+    }
+    if (aborted)
+    {
+        result.status |= statusAborted;
+    }
+
+    return result;
+}
+
+void EvaluatorControl::evaluatorThreadRun()
+{
+    // Each thread has its own copy of the evaluator.
+    Evaluator evaluator(_evaluator);
+
+    while (true)
+    {
+        PointMessage point;
+        {
+            std::unique_lock<std::mutex> lock(_queueMutex);
+            while (!_stopThreads && _pointQueue.empty())
+            {
+                _pointQueueCond.wait(lock);
+            }
+            if (_pointQueue.empty())
+            {
+                // _stopThreads is set and there is nothing left to do.
+                break;
+            }
+            point = _pointQueue.front();
+            _pointQueue.pop_front();
+        }
+
+        ResultMessage result = evaluate(evaluator, point);
+
+        {
+            std::lock_guard<std::mutex> lock(_queueMutex);
+            _resultVector.push_back(result);
+            _resultCond.notify_one();
+        }
+    }
+}
+
+bool EvaluatorControl::getNewPointsToEvaluate(std::vector<PointMessage> &pointVector)
 {
     // Probe if there is a Send from master waiting to be received by this worker.
 
@@ -47,37 +176,56 @@ bool EvaluatorControl::getNewPointToEvaluate(double &x)
 
     if (flagNewPointToEval > 0)
     {
-        // Receive X
+        // Receive ids and Xs
         // MPI_Recv(address, maxcount, datatype, source, tag, comm, status)
-        // address: Address of the x to evaluate.
-        // maxcount: Number of entries starting at address - Here, 1.
-        // datatype: Here, MPI_DOUBLE.
+        // address: Address of the PointMessages holding ids and xs.
+        // maxcount: Number of entries starting at address - Here, size of the message in bytes.
+        // datatype: Here, MPI_BYTE.
         // source: Rank of the MPI "master". Here, always 0.
         // tag: Used for message matching - Here, 0 for master-to-worker, 1 for worker-to-master.
         // comm: Communication context - Here, MPI_COMM_WORLD.
         // status: Information about the actual message size, source, and tag.
         //
-        MPI_Request request;
-        MPI_Recv(&x, 1, MPI_DOUBLE, 0, tagPointToEvaluate, MPI_COMM_WORLD, &status);
-   
+        int nbBytes = 0;
+        MPI_Get_count(&status, MPI_BYTE, &nbBytes);
+        size_t nbPoints = nbBytes / sizeof(PointMessage);
+        size_t firstIndex = pointVector.size();
+        pointVector.resize(firstIndex + nbPoints);
+        MPI_Recv(&pointVector[firstIndex], nbBytes, MPI_BYTE, 0, tagPointToEvaluate, MPI_COMM_WORLD, &status);
+
         newPointReceived = true;
     }
 
     return newPointReceived;
 }
 
-void EvaluatorControl::sendPointToMaster(const double &x, const double &f, const double &eval_ok)
+void EvaluatorControl::sendPointsToMaster(const std::vector<ResultMessage> &resultVector)
 {
-    // Send back evaluation to master
-    // Although x is not new info, sending it back in the same message along with f and eval_ok
-    // seems easier to manage.
-    // Sending as 3 double for simplicity.
-    double evalpoint[3];
-    evalpoint[0] = x;
-    evalpoint[1] = f;
-    evalpoint[2] = eval_ok;
-
-    MPI_Send(&evalpoint, 3, MPI_DOUBLE, 0, tagEvaluatedPoint, MPI_COMM_WORLD);
+    if (resultVector.empty())
+    {
+        return;
+    }
+
+    // Send back evaluations to master
+    // x is not sent back: the master retrieves it from its point store using id.
+    MPI_Send(resultVector.data(), resultVector.size() * sizeof(ResultMessage), MPI_BYTE, 0, tagEvaluatedPoint, MPI_COMM_WORLD);
+}
+
+void EvaluatorControl::receiveThreshold()
+{
+    // Only the latest threshold matters.
+    MPI_Status status;
+    int flagThreshold = 1;
+    while (flagThreshold > 0)
+    {
+        MPI_Iprobe(0, tagThreshold, MPI_COMM_WORLD, &flagThreshold, &status);
+        if (flagThreshold > 0)
+        {
+            double threshold = 0.0;
+            MPI_Recv(&threshold, 1, MPI_DOUBLE, 0, tagThreshold, MPI_COMM_WORLD, &status);
+            _threshold = threshold;
+        }
+    }
 }
 
 bool EvaluatorControl::isEvaluationDone()
@@ -1,5 +1,13 @@
 #include <mpi.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "Evaluator.hpp"
@@ -8,21 +16,102 @@ const int tagPointToEvaluate = 0;
 const int tagEvaluatedPoint = 1;
 const int tagEvaluationDone = 2;
 const int tagWorkerDone = 3;
+const int tagThreshold = 4;
+
+// Message sent from master to worker: a point to evaluate.
+// id is the index of the point in the master's point store.
+struct PointMessage
+{
+    uint64_t id;
+    double   x;
+};
+
+// Status bits of an evaluation result.
+const uint32_t statusEvalOk = 1;
+// The evaluation stopped early: f is only a lower bound.
+const uint32_t statusAborted = 2;
+
+// Message sent from worker to master: the result of an evaluation.
+// x is not sent back. The master uses id to retrieve the point from its store,
+// so the size of this message does not depend on the dimension of x.
+struct ResultMessage
+{
+    uint64_t id;
+    double   f;
+    double   c[nbConstraints];
+    uint32_t status;
+};
+
+// Messages are sent as raw bytes. This assumes all ranks share the same
+// architecture, which is the case on our clusters.
+// Each message holds one or more PointMessage or ResultMessage. The receiver
+// gets the number of entries from the message size.
+
+// Rank of the worker that gets the pointIndex-th point sent since the start.
+// Points are distributed round-robin over the worldSize-1 workers.
+// pointIndex counts the points of all batches, so that batches smaller than
+// the number of workers do not always go to the same workers.
+inline int roundRobinWorkerRank(const size_t pointIndex, const int worldSize)
+{
+    return static_cast<int>(pointIndex % (worldSize-1)) + 1;
+}
+
+// With several evaluator threads, maximum time in seconds the main thread of
+// a worker waits for a result before it checks for messages again.
+const double resultWaitTimeout = 1e-3;
 
 class EvaluatorControl
 {
     Evaluator _evaluator;
+
+    // Number of evaluator threads on this rank.
+    // With 1 thread, evaluations are done by the main thread.
+    // With more threads, the main thread only does the MPI communication
+    // (MPI_THREAD_FUNNELED), and the evaluator threads get their points from
+    // _pointQueue and put their results in _resultVector.
+    int _nbThreads;
+    bool _stopThreads;
+    std::deque<PointMessage> _pointQueue;
+    std::vector<ResultMessage> _resultVector;
+    std::mutex _queueMutex;
+    std::condition_variable _pointQueueCond;
+    std::condition_variable _resultCond;
+
+    // Threshold on f sent by master, checked by evaluators to stop early.
+    // It is updated by the main thread only.
+    std::atomic<double> _threshold;
+
+    // Print debug messages.
+    bool _verbose;
+
+    // Evaluate one point.
+    ResultMessage evaluate(Evaluator &evaluator, const PointMessage &point);
+
+    // Loop of an evaluator thread.
+    void evaluatorThreadRun();
+
 public:
     // Constructor
-    EvaluatorControl(Evaluator evaluator)
-      : _evaluator(evaluator)
+    EvaluatorControl(Evaluator evaluator, int nbThreads = 1)
+      : _evaluator(evaluator),
+        _nbThreads(nbThreads),
+        _stopThreads(false),
+        _threshold(std::numeric_limits<double>::infinity()),
+        _verbose(true)
     {}
 
+    void setVerbose(const bool verbose) { _verbose = verbose; }
+
     void run();
 
-    bool getNewPointToEvaluate(double &x);
+    // Receive the next message of points sent by master to this worker, and add them to pointVector.
+    bool getNewPointsToEvaluate(std::vector<PointMessage> &pointVector);
+
+    // Send all results in resultVector to master, in a single message.
+    void sendPointsToMaster(const std::vector<ResultMessage> &resultVector);
 
-    void sendPointToMaster(const double &x, const double &f, const double &eval_ok);
+    // Receive the latest threshold sent by master, if any.
+    void receiveThreshold();
 
     bool isEvaluationDone();
 
@@ -0,0 +1,163 @@
+#include "MasterControl.hpp"
+
+// Send the points of pointsVector given by pointIds to worldSize-1 workers.
+// Points are distributed round-robin, and all points for a worker are sent in
+// a single message, so that a worker running many evaluator threads gets work
+// for all of them at once.
+// nbPointsAlreadySent is the number of points sent in previous batches: the
+// round-robin continues where the previous batch stopped.
+// The points are marked in flight in pointState.
+// Returns: the number of points sent to each rank.
+std::vector<int> sendPointsToWorkers(const std::vector<double> &pointsVector, const std::vector<uint64_t> &pointIds,
+                         const size_t nbPointsAlreadySent, const int worldSize,
+                         std::vector<PointState> &pointState)
+{
+    std::vector<std::vector<PointMessage> > pointsPerWorker(worldSize);
+    std::vector<int> nbPointsPerWorker(worldSize, 0);
+    int nbPoints = pointIds.size();
+    for (int pointIndex = 0; pointIndex < nbPoints; pointIndex++)
+    {
+        int workerRank = roundRobinWorkerRank(nbPointsAlreadySent + pointIndex, worldSize);
+        // The id of a point is its index in pointsVector.
+        PointMessage point;
+        point.id = pointIds[pointIndex];
+        point.x = pointsVector[point.id];
+        pointsPerWorker[workerRank].push_back(point);
+        pointState[point.id] = pointInFlight;
+    }
+
+    for (int workerRank = 1; workerRank < worldSize; workerRank++)
+    {
+        nbPointsPerWorker[workerRank] = pointsPerWorker[workerRank].size();
+        if (pointsPerWorker[workerRank].empty())
+        {
+            continue;
+        }
+        // MPI_Send(address, count, datatype, destination, tag, comm)
+        // address: Address of the PointMessages holding the ids and xs to evaluate.
+        // count: Number of entries starting at address - Here, size of the PointMessages in bytes.
+        // datatype: Here, MPI_BYTE.
+        // destination: Rank of the MPI "worker". Here, given by the for loop.
+        // tag: Used for message matching - Here, 0 for master-to-worker, 1 for worker-to-master.
+        // comm: Communication context - Here, MPI_COMM_WORLD.
+        //std::cout << "Master sends " << pointsPerWorker[workerRank].size() << " points to worker " << workerRank << std::endl;
+        MPI_Send(pointsPerWorker[workerRank].data(),
+                 pointsPerWorker[workerRank].size() * sizeof(PointMessage),
+                 MPI_BYTE, workerRank, tagPointToEvaluate, MPI_COMM_WORLD);
+    }
+
+    return nbPointsPerWorker;
+}
+
+
+// Master receives evaluated points.
+// Results are joined back to their point in pointsVector by id.
+// pointState keeps track of the ids in flight. Results for ids that were
+// never sent, or that were already received, are ignored.
+// Returns: true when nbPointsSent points have been received.
+bool receiveEvaluatedPoints(const int worldSize,
+                            const size_t nbPointsSent,
+                            const std::vector<double> &pointsVector,
+                            std::vector<PointState> &pointState,
+                            std::vector<EvalPoint> &evalpointVector)
+{
+    bool allPointsEvaluated = false;
+
+    // Go around all workers.
+    for (int workerRank = 1; workerRank < worldSize; workerRank++)
+    {
+        // Probe if there is a Send from that worker waiting to be received.
+        // MPI_Iprobe(source, tag, comm, flag, status)
+        MPI_Status status;
+        int newEvalPointReceived = 0;
+        MPI_Iprobe(workerRank, tagEvaluatedPoint, MPI_COMM_WORLD, &newEvalPointReceived, &status);
+        if (newEvalPointReceived > 0)
+        {
+            // Actually receive evaluations.
+            // A worker may send several results in a single message.
+            int nbBytes = 0;
+            MPI_Get_count(&status, MPI_BYTE, &nbBytes);
+            std::vector<ResultMessage> resultVector(nbBytes / sizeof(ResultMessage));
+            MPI_Recv(resultVector.data(), nbBytes, MPI_BYTE, workerRank, tagEvaluatedPoint, MPI_COMM_WORLD, &status);
+            for (size_t i = 0; i < resultVector.size(); i++)
+            {
+                const ResultMessage &result = resultVector[i];
+                if (result.id >= pointState.size() || pointInFlight != pointState[result.id])
+                {
+                    std::cerr << "Warning: ignoring unexpected result for point id " << result.id << " from worker " << workerRank << std::endl;
+                    continue;
+                }
+                pointState[result.id] = pointReceived;
+                double x = pointsVector[result.id];
+                bool eval_ok = (result.status & statusEvalOk);
+                bool aborted = (result.status & statusAborted);
+                bool feasible = true;
+                for (int c = 0; c < nbConstraints; c++)
+                {
+                    feasible = feasible && (result.c[c] <= 0.0);
+                }
+                EvalPoint evalpoint(result.id, x, result.f, eval_ok, aborted, feasible, workerRank);
+                evalpointVector.push_back(evalpoint);
+            }
+            if (evalpointVector.size() == nbPointsSent)
+            {
+                allPointsEvaluated = true;
+            }
+        }
+    }
+
+    return allPointsEvaluated;
+}
+
+
+// Master sends word to workers that evaluations are done.
+void sendEvaluationDoneToWorkers(const int worldSize)
+{
+    int done = 1;
+    for (int workerRank = 1; workerRank < worldSize; workerRank++)
+    {
+        MPI_Send(&done, 1, MPI_INT, workerRank, tagEvaluationDone, MPI_COMM_WORLD);
+    }
+}
+
+
+// Master sends the new threshold on f to workers, so that evaluations that
+// cannot beat it may stop early.
+void sendThresholdToWorkers(const double threshold, const int worldSize)
+{
+    for (int workerRank = 1; workerRank < worldSize; workerRank++)
+    {
+        MPI_Send(&threshold, 1, MPI_DOUBLE, workerRank, tagThreshold, MPI_COMM_WORLD);
+    }
+}
+
+
+// Master receives "done" from workers, until we get worldSize.
+void waitAllWorkersDone(const int worldSize)
+{
+    bool allWorkersDone = false;
+
+    MPI_Status status;
+    int flagDone = 0;
+    int workerDone = 0;
+    int nbWorkersDone = 0;
+
+    while (!allWorkersDone)
+    {
+        for (int workerRank = 1; workerRank < worldSize && !allWorkersDone; workerRank++)
+        {
+            MPI_Iprobe(workerRank, tagWorkerDone, MPI_COMM_WORLD, &flagDone, &status);
+            if (flagDone > 0)
+            {
+                MPI_Recv(&workerDone, 1, MPI_INT, workerRank, tagWorkerDone, MPI_COMM_WORLD, &status);
+                nbWorkersDone++;
+                if ((worldSize-1) == nbWorkersDone)
+                {
+                    allWorkersDone = true;
+                }
+            }
+        }
+    }
+
+}
+
@@ -0,0 +1,45 @@
+#include <mpi.h>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "EvalPoint.hpp"
+#include "EvaluatorControl.hpp"
+
+// Master side of the master/worker protocol.
+// The worker side is in EvaluatorControl.
+
+// State of a point of the master's point store, indexed by id.
+enum PointState
+{
+    pointNotSent,   // Not sent to a worker, e.g. skipped by screening.
+    pointInFlight,  // Sent to a worker, result not received yet.
+    pointReceived   // Result received.
+};
+
+// Send the points of pointsVector given by pointIds to worldSize-1 workers,
+// and mark them in flight in pointState.
+// nbPointsAlreadySent is the number of points sent in previous batches.
+// Returns: the number of points sent to each rank.
+std::vector<int> sendPointsToWorkers(const std::vector<double> &pointsVector, const std::vector<uint64_t> &pointIds,
+                         const size_t nbPointsAlreadySent, const int worldSize,
+                         std::vector<PointState> &pointState);
+
+// Master receives evaluated points.
+// Only results for points in flight are accepted.
+// Returns: true when nbPointsSent points have been received.
+bool receiveEvaluatedPoints(const int worldSize,
+                            const size_t nbPointsSent,
+                            const std::vector<double> &pointsVector,
+                            std::vector<PointState> &pointState,
+                            std::vector<EvalPoint> &evalpointVector);
+
+// Master sends word to workers that evaluations are done.
+void sendEvaluationDoneToWorkers(const int worldSize);
+
+// Master sends the new threshold on f to workers.
+void sendThresholdToWorkers(const double threshold, const int worldSize);
+
+// Master receives "done" from workers, until we get worldSize.
+void waitAllWorkersDone(const int worldSize);
+
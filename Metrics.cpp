@@ -0,0 +1,144 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+#include "Metrics.hpp"
+
+MetricsPublisher::MetricsPublisher(const std::string &filename, const int worldSize, const double startTime,
+                                   const double period, const double windowLength)
+  : _filename(filename),
+    _period(period),
+    _windowLength(windowLength),
+    _startTime(startTime),
+    _nextPublishTime(startTime),
+    _nbDispatched(0),
+    _nbCompleted(0),
+    _nbSkipped(0),
+    _bestF(std::numeric_limits<double>::infinity()),
+    _workerLastSeen(worldSize, -1.0),
+    _workerInFlight(worldSize, 0),
+    _workerWaitingSince(worldSize, startTime)
+{}
+
+void MetricsPublisher::addDispatched(const std::vector<int> &nbPointsPerWorker, const double now)
+{
+    for (size_t workerRank = 1; workerRank < nbPointsPerWorker.size() && workerRank < _workerInFlight.size(); workerRank++)
+    {
+        int nbPoints = nbPointsPerWorker[workerRank];
+        if (nbPoints <= 0)
+        {
+            continue;
+        }
+        // An idle worker starts waiting for its first result now.
+        if (0 == _workerInFlight[workerRank])
+        {
+            _workerWaitingSince[workerRank] = now;
+        }
+        _workerInFlight[workerRank] += nbPoints;
+        _nbDispatched += nbPoints;
+    }
+}
+
+void MetricsPublisher::publish(const double now, const bool done)
+{
+    _nextPublishTime = now + _period;
+    if (_filename.empty())
+    {
+        return;
+    }
+
+    // Evals/s over the sliding window.
+    _window.push_back(std::make_pair(now, _nbCompleted));
+    while (_window.size() > 2 && now - _window[1].first >= _windowLength)
+    {
+        _window.pop_front();
+    }
+    double evalsPerSecond = 0.0;
+    double windowTime = now - _window.front().first;
+    if (windowTime > 0.0)
+    {
+        evalsPerSecond = (_nbCompleted - _window.front().second) / windowTime;
+    }
+
+    std::string tmpFilename = _filename + ".tmp";
+    std::ofstream out(tmpFilename.c_str());
+    if (!out)
+    {
+        return;
+    }
+    double wallTime = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    out << std::fixed << std::setprecision(6);
+    out << "{\"state\": \"" << (done ? "done" : "running") << "\""
+        << ", \"wall_time\": " << wallTime
+        << ", \"elapsed_s\": " << now - _startTime
+        << ", \"dispatched\": " << _nbDispatched
+        << ", \"completed\": " << _nbCompleted
+        << ", \"in_flight\": " << _nbDispatched - _nbCompleted
+        << ", \"skipped\": " << _nbSkipped
+        << ", \"evals_per_s\": " << evalsPerSecond
+        << ", \"best_f\": ";
+    if (std::isinf(_bestF))
+    {
+        out << "null";
+    }
+    else
+    {
+        out << _bestF;
+    }
+    // Seconds since the last result of each worker, null if none yet.
+    out << ", \"worker_last_seen_s_ago\": {";
+    for (size_t workerRank = 1; workerRank < _workerLastSeen.size(); workerRank++)
+    {
+        if (workerRank > 1)
+        {
+            out << ", ";
+        }
+        out << "\"" << workerRank << "\": ";
+        if (_workerLastSeen[workerRank] < 0.0)
+        {
+            out << "null";
+        }
+        else
+        {
+            out << now - _workerLastSeen[workerRank];
+        }
+    }
+    out << "}";
+    out << ", \"worker_in_flight\": {";
+    for (size_t workerRank = 1; workerRank < _workerInFlight.size(); workerRank++)
+    {
+        if (workerRank > 1)
+        {
+            out << ", ";
+        }
+        out << "\"" << workerRank << "\": " << _workerInFlight[workerRank];
+    }
+    out << "}";
+    // Seconds since the last progress of each worker with points in flight,
+    // null if the worker is idle.
+    out << ", \"worker_waiting_s\": {";
+    for (size_t workerRank = 1; workerRank < _workerInFlight.size(); workerRank++)
+    {
+        if (workerRank > 1)
+        {
+            out << ", ";
+        }
+        out << "\"" << workerRank << "\": ";
+        if (0 == _workerInFlight[workerRank])
+        {
+            out << "null";
+        }
+        else
+        {
+            out << now - _workerWaitingSince[workerRank];
+        }
+    }
+    out << "}}" << std::endl;
+    out.close();
+
+    std::rename(tmpFilename.c_str(), _filename.c_str());
+}
+
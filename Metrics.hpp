@@ -0,0 +1,83 @@
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// Snapshot of the progress of the master, written periodically to a file
+// so that a job monitor can follow a run and detect stalled workers.
+//
+// Counters are updated by the master loop at the cost of an increment.
+// publishIfDue only compares times, except once per period where the
+// snapshot is written. The snapshot is written to <filename>.tmp, then
+// renamed to <filename>, so that readers never see a partial file.
+// If filename is empty, nothing is written.
+//
+// Stall detection: points are dispatched statically, so a worker with no
+// point in flight is idle, not stalled, however long ago it was last seen.
+// A worker is stalled if it has points in flight and has not made progress
+// (returned a result, or received work while idle) for longer than an
+// evaluation should take: worker_waiting_s is that time, null when idle.
+//
+// Snapshots are only written from the master loop. If the master blocks,
+// e.g. in an MPI_Send to a hung worker, the file stops being updated:
+// wall_time (seconds since the epoch) then falls behind the monitor's clock.
+// The file's mtime gives the same information.
+class MetricsPublisher
+{
+private:
+    std::string _filename;
+    double  _period;            // Seconds between snapshots.
+    double  _windowLength;      // Seconds over which evals/s is computed.
+    double  _startTime;
+    double  _nextPublishTime;
+
+    size_t  _nbDispatched;
+    size_t  _nbCompleted;
+    size_t  _nbSkipped;
+    double  _bestF;
+    std::vector<double> _workerLastSeen;        // Time of last result, per rank. Negative if never.
+    std::vector<size_t> _workerInFlight;        // Points sent and not received, per rank.
+    std::vector<double> _workerWaitingSince;    // Time of last progress, per rank.
+
+    // (time, _nbCompleted) at the previous snapshots, for the sliding window.
+    std::deque<std::pair<double, size_t> > _window;
+
+    void publish(const double now, const bool done);
+
+public:
+    // Constructor
+    // Times are given by MPI_Wtime.
+    MetricsPublisher(const std::string &filename, const int worldSize, const double startTime,
+                     const double period = 1.0, const double windowLength = 10.0);
+
+    // nbPointsPerWorker: number of points sent to each rank, as returned by
+    // sendPointsToWorkers.
+    void addDispatched(const std::vector<int> &nbPointsPerWorker, const double now);
+    void addSkipped(const size_t nbPoints)      { _nbSkipped += nbPoints; }
+    void addCompleted(const int workerRank, const double now)
+    {
+        _nbCompleted++;
+        _workerLastSeen[workerRank] = now;
+        _workerWaitingSince[workerRank] = now;
+        if (_workerInFlight[workerRank] > 0)
+        {
+            _workerInFlight[workerRank]--;
+        }
+    }
+    void setBestF(const double bestF)           { _bestF = bestF; }
+
+    // Write a snapshot if the period has elapsed since the last one.
+    void publishIfDue(const double now)
+    {
+        if (now >= _nextPublishTime)
+        {
+            publish(now, false);
+        }
+    }
+
+    // Write the final snapshot.
+    void publishDone(const double now) { publish(now, true); }
+};
+
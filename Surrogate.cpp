@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "Surrogate.hpp"
+
+Surrogate::Surrogate()
+  : _fitted(false),
+    _valid(false)
+{
+    for (int i = 0; i < 5; i++)
+    {
+        _sumX[i] = 0.0;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        _sumFX[i] = 0.0;
+        _coef[i] = 0.0;
+    }
+}
+
+void Surrogate::addPoint(const double x, const double f)
+{
+    // A single non-finite value would poison the sums for the rest of the run.
+    if (!std::isfinite(x) || !std::isfinite(f))
+    {
+        return;
+    }
+    double xPow = 1.0;
+    for (int i = 0; i < 5; i++)
+    {
+        _sumX[i] += xPow;
+        if (i < 3)
+        {
+            _sumFX[i] += f * xPow;
+        }
+        xPow *= x;
+    }
+    _fitted = false;
+}
+
+bool Surrogate::isReady()
+{
+    // A quadratic needs at least 3 points.
+    if (_sumX[0] < 3)
+    {
+        return false;
+    }
+    fit();
+    return _valid;
+}
+
+double Surrogate::predict(const double x)
+{
+    fit();
+    return _coef[0] + _coef[1] * x + _coef[2] * x * x;
+}
+
+void Surrogate::fit()
+{
+    if (_fitted)
+    {
+        return;
+    }
+    _fitted = true;
+
+    // Solve the 3x3 normal equations M * coef = _sumFX, with M[i][j] = _sumX[i+j],
+    // using Cramer's rule.
+    double m[3][3];
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            m[i][j] = _sumX[i+j];
+        }
+    }
+
+    double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+               - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+               + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+
+    // Points too close together: the model is not usable.
+    // With <=, a zero determinant is rejected even if the right-hand side is
+    // zero too, e.g. when all points are at x = 0.
+    if (std::fabs(det) <= 1e-12 * std::fabs(m[0][0] * m[1][1] * m[2][2]))
+    {
+        _valid = false;
+        return;
+    }
+
+    for (int k = 0; k < 3; k++)
+    {
+        // Replace column k by the right-hand side.
+        double mk[3][3];
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                mk[i][j] = (j == k) ? _sumFX[i] : m[i][j];
+            }
+        }
+        double detK = mk[0][0] * (mk[1][1] * mk[2][2] - mk[1][2] * mk[2][1])
+                    - mk[0][1] * (mk[1][0] * mk[2][2] - mk[1][2] * mk[2][0])
+                    + mk[0][2] * (mk[1][0] * mk[2][1] - mk[1][1] * mk[2][0]);
+        _coef[k] = detK / det;
+    }
+    // Predictions are used as sort keys by screen, so they must not be NaN.
+    _valid = std::isfinite(_coef[0]) && std::isfinite(_coef[1]) && std::isfinite(_coef[2]);
+}
+
+std::vector<uint64_t> Surrogate::screen(const std::vector<uint64_t> &candidateIds,
+                                        const std::vector<double> &pointsVector,
+                                        const ScreeningPolicy policy,
+                                        const double keepRatio)
+{
+    if (screeningNone == policy || !isReady())
+    {
+        return candidateIds;
+    }
+
+    // Sort candidates by predicted f. We are minimizing.
+    std::vector<std::pair<double, uint64_t> > predictions;
+    for (size_t i = 0; i < candidateIds.size(); i++)
+    {
+        uint64_t id = candidateIds[i];
+        predictions.push_back(std::make_pair(predict(pointsVector[id]), id));
+    }
+    std::stable_sort(predictions.begin(), predictions.end());
+
+    size_t nbKept = predictions.size();
+    if (screeningPrune == policy)
+    {
+        // keepRatio is expected in (0, 1]. Clamp it so that the cast is defined.
+        double ratio = std::min(std::max(keepRatio, 0.0), 1.0);
+        nbKept = static_cast<size_t>(std::ceil(ratio * predictions.size()));
+        nbKept = std::min(nbKept, predictions.size());
+    }
+
+    std::vector<uint64_t> screenedIds;
+    for (size_t i = 0; i < nbKept; i++)
+    {
+        screenedIds.push_back(predictions[i].second);
+    }
+
+    return screenedIds;
+}
+
@@ -0,0 +1,52 @@
+#include <cstdint>
+#include <vector>
+
+
+// Screening policy applied by the master to candidate points before dispatch.
+enum ScreeningPolicy
+{
+    screeningNone,  // Send all points, in generation order.
+    screeningRank,  // Send all points, most promising first.
+    screeningPrune  // Send only the most promising points, most promising first.
+};
+
+
+// Cheap quadratic model of f: f(x) ~ a + b*x + c*x^2, fitted by least squares
+// on the evaluated points.
+// The sums of the normal equations are updated incrementally by addPoint, so
+// adding a point is O(1) and does not stall the master loop.
+class Surrogate
+{
+private:
+    double  _sumX[5];   // Sums of x^0 .. x^4
+    double  _sumFX[3];  // Sums of f*x^0 .. f*x^2
+    double  _coef[3];   // a, b, c
+    bool    _fitted;    // true if _coef is up to date with the sums.
+    bool    _valid;     // true if the normal equations could be solved.
+
+    void fit();
+
+public:
+    // Constructor
+    Surrogate();
+
+    // Add an evaluated point to the model. Non-finite x or f are ignored.
+    void addPoint(const double x, const double f);
+
+    // Returns: true if the model has enough points to be used.
+    bool isReady();
+
+    // Predicted value of f at x.
+    double predict(const double x);
+
+    // Screen candidate points, given by their ids in pointsVector.
+    // Returns: the ids of the points to send, in the order they should be sent.
+    // With screeningPrune, only the ceil(keepRatio * nb candidates) points with
+    // the lowest prediction are kept.
+    // If the model is not ready, candidates are returned as is.
+    std::vector<uint64_t> screen(const std::vector<uint64_t> &candidateIds,
+                                 const std::vector<double> &pointsVector,
+                                 const ScreeningPolicy policy,
+                                 const double keepRatio);
+};
+
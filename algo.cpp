@@ -1,9 +1,15 @@
 #include <mpi.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <string>
 #include <vector>
 
-#include "EvalPoint.hpp"
-#include "EvaluatorControl.hpp"
+#include "MasterControl.hpp"
+#include "Metrics.hpp"
+#include "Surrogate.hpp"
 
 // Generate nbPoints random values between 1 and 100
 std::vector<double> generatePoints(const int nbPoints)
@@ -22,109 +28,15 @@ std::vector<double> generatePoints(const int nbPoints)
 }
 
 
-// Send nbPoints to worldSize-1 workers.
-void sendPointsToWorkers(const std::vector<double> pointsVector, const int worldSize)
-{
-    int nbPoints = pointsVector.size();
-    for (int pointIndex = 0; pointIndex < nbPoints; pointIndex++)
-    {
-        int workerRank = pointIndex % (worldSize-1) + 1;
-        // MPI_Send(address, count, datatype, destination, tag, comm)
-        // address: Address of the x to evaluate.
-        // count: Number of entries starting at address - Here, 1.
-        // datatype: Here, MPI_DOUBLE.
-        // destination: Rank of the MPI "worker". Here, given by the for loop.
-        // tag: Used for message matching - Here, 0 for master-to-worker, 1 for worker-to-master.
-        // comm: Communication context - Here, MPI_COMM_WORLD.
-        double x = pointsVector[pointIndex];
-        //std::cout << "Master sends " << x << " to worker " << workerRank << std::endl;
-        MPI_Send(&x, 1, MPI_DOUBLE, workerRank, tagPointToEvaluate, MPI_COMM_WORLD);
-    }
-}
-
-
-// Master receives evaluated points.
-bool receiveEvaluatedPoints(const int worldSize, const int nbPoints, std::vector<EvalPoint> &evalpointVector)
-{
-    bool allPointsEvaluated = false;
-
-    // Go around all workers.
-    for (int workerRank = 1; workerRank < worldSize; workerRank++)
-    {
-        // Probe if there is a Send from that worker waiting to be received.
-        // MPI_Iprobe(source, tag, comm, flag, status)
-        MPI_Status status;
-        int newEvalPointReceived = 0;
-        MPI_Iprobe(workerRank, tagEvaluatedPoint, MPI_COMM_WORLD, &newEvalPointReceived, &status);
-        if (newEvalPointReceived > 0)
-        {
-            // Actually receive evaluation.
-            double xfe[3];
-            MPI_Status status;
-            MPI_Recv(&xfe, 3, MPI_DOUBLE, workerRank, 1, MPI_COMM_WORLD, &status);
-            double x = xfe[0];
-            double f = xfe[1];
-            double eval_ok = xfe[2];
-            EvalPoint evalpoint(x, f, eval_ok, workerRank);
-            evalpointVector.push_back(evalpoint);
-            if (evalpointVector.size() == nbPoints)
-            {
-                allPointsEvaluated = true;
-            }
-        }
-    }
-
-    return allPointsEvaluated;
-}
-
-
-// Master sends word to workers that evaluations are done.
-void sendEvaluationDoneToWorkers(const int worldSize)
-{
-    int done = 1;
-    for (int workerRank = 1; workerRank < worldSize; workerRank++)
-    {
-        MPI_Send(&done, 1, MPI_INT, workerRank, tagEvaluationDone, MPI_COMM_WORLD);
-    }
-}
-
-
-// Master receives "done" from workers, until we get worldSize.
-void waitAllWorkersDone(const int worldSize)
-{
-    bool allWorkersDone = false;
-
-    MPI_Status status;
-    int flagDone = 0;
-    int workerDone = 0;
-    int nbWorkersDone = 0;
-
-    while (!allWorkersDone)
-    {
-        for (int workerRank = 1; workerRank < worldSize && !allWorkersDone; workerRank++)
-        {
-            MPI_Iprobe(workerRank, tagWorkerDone, MPI_COMM_WORLD, &flagDone, &status);
-            if (flagDone > 0)
-            {
-                MPI_Recv(&workerDone, 1, MPI_INT, workerRank, tagWorkerDone, MPI_COMM_WORLD, &status);
-                nbWorkersDone++;
-                if ((worldSize-1) == nbWorkersDone)
-                {
-                    allWorkersDone = true;
-                }
-            }
-        }
-    }
-
-}
-
-
 int main(int argc, char** argv)
 {
-    // Usage: mpirun -np <number of processes> -f <hostfile> algo
+    // Usage: mpirun -np <number of processes> -f <hostfile> algo [nb points] [batch size] [none|rank|prune] [keep ratio] [nb threads per worker] [metrics file]
 
     // Initialize the MPI environment
-    MPI_Init(&argc, &argv);
+    // Workers may run several evaluator threads, but only their main thread
+    // calls MPI.
+    int threadSupport = MPI_THREAD_SINGLE;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &threadSupport);
 
     // initialize random seed
     srand(time(NULL));
@@ -144,32 +56,148 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    // Parse options on all ranks, so that all ranks stop if one is invalid.
+    int nbPoints = 100;
+    if (argc >= 2)
+    {
+        nbPoints = std::atoi(argv[1]);
+    }
+    // Points are sent in batches. The surrogate is updated with the results
+    // of each batch, and used to screen the next batch.
+    // By default, all points are sent in a single batch, without screening.
+    int batchSize = nbPoints;
+    if (argc >= 3)
+    {
+        batchSize = std::max(1, std::atoi(argv[2]));
+    }
+    bool validOptions = true;
+    ScreeningPolicy screeningPolicy = screeningNone;
+    if (argc >= 4)
+    {
+        if (0 == strcmp(argv[3], "rank"))
+        {
+            screeningPolicy = screeningRank;
+        }
+        else if (0 == strcmp(argv[3], "prune"))
+        {
+            screeningPolicy = screeningPrune;
+        }
+        else if (0 != strcmp(argv[3], "none"))
+        {
+            validOptions = false;
+        }
+    }
+    // Fraction of each batch kept by screeningPrune, in (0, 1].
+    double keepRatio = 0.5;
+    if (argc >= 5)
+    {
+        char *end = NULL;
+        keepRatio = std::strtod(argv[4], &end);
+        if (end == argv[4] || *end != '\0' || !(keepRatio > 0.0))
+        {
+            validOptions = false;
+        }
+        keepRatio = std::min(keepRatio, 1.0);
+    }
+    // Number of evaluator threads on each worker rank. Typically, one rank
+    // is launched per node, with one thread per core.
+    int nbThreads = 1;
+    if (argc >= 6)
+    {
+        nbThreads = std::max(1, std::atoi(argv[5]));
+    }
+    // Progress snapshots are written to this file during the run.
+    std::string metricsFilename;
+    if (argc >= 7)
+    {
+        metricsFilename = argv[6];
+    }
+    if (!validOptions)
+    {
+        if (0 == worldRank)
+        {
+            std::cout << "Usage: mpirun -np <nb of processes> -f <hostfile> " << argv[0]
+                      << " [nb points] [batch size] [none|rank|prune] [keep ratio in (0, 1]]"
+                      << " [nb threads per worker] [metrics file]" << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
     std::cout << "VRM: Launch " << argv[0] << " rank " << worldRank << std::endl;
     // Start EvaluatorControl on workers (not on master for now).
     if (0 != worldRank)
     {
+        if (nbThreads > 1 && threadSupport < MPI_THREAD_FUNNELED)
+        {
+            std::cerr << "Warning: MPI_THREAD_FUNNELED is not supported. Using 1 thread on rank " << worldRank << std::endl;
+            nbThreads = 1;
+        }
         Evaluator evaluator;
-        EvaluatorControl evc(evaluator);
+        EvaluatorControl evc(evaluator, nbThreads);
         evc.run();
     }
 
     // The rest of the algo is in master only
     if (0 == worldRank)
     {
-        int nbPoints = 100;
-        if (argc >= 2)
-        {
-            nbPoints = std::atoi(argv[1]);
-        }
         std::cout << "VRM: Generate points in rank " << worldRank << "... etc." << std::endl;
         std::vector<double> pointsVector = generatePoints(nbPoints);
+        std::vector<PointState> pointState(nbPoints, pointNotSent);
         std::vector<EvalPoint> evalpointVector;
         std::cout << "Number of points to evaluate: " << nbPoints << std::endl;
-        sendPointsToWorkers(pointsVector, worldSize);
-        bool allPointsReceived = false;
-        while (!allPointsReceived)
+
+        Surrogate surrogate;
+        // Best f of feasible, fully evaluated points. It is sent to workers
+        // as threshold each time it improves.
+        double bestF = std::numeric_limits<double>::infinity();
+        size_t nbPointsSent = 0;
+        size_t nbPointsSkipped = 0;
+        MetricsPublisher metrics(metricsFilename, worldSize, MPI_Wtime());
+        for (int batchStart = 0; batchStart < nbPoints; batchStart += batchSize)
         {
-            allPointsReceived = receiveEvaluatedPoints(worldSize, nbPoints, evalpointVector);
+            std::vector<uint64_t> candidateIds;
+            for (int i = batchStart; i < nbPoints && i < batchStart + batchSize; i++)
+            {
+                candidateIds.push_back(i);
+            }
+            std::vector<uint64_t> pointIds = surrogate.screen(candidateIds, pointsVector, screeningPolicy, keepRatio);
+            nbPointsSkipped += candidateIds.size() - pointIds.size();
+            std::vector<int> nbPointsPerWorker = sendPointsToWorkers(pointsVector, pointIds, nbPointsSent, worldSize, pointState);
+            nbPointsSent += pointIds.size();
+            metrics.addSkipped(candidateIds.size() - pointIds.size());
+            metrics.addDispatched(nbPointsPerWorker, MPI_Wtime());
+
+            size_t nbPointsModeled = evalpointVector.size();
+            bool allPointsReceived = pointIds.empty();
+            while (!allPointsReceived)
+            {
+                allPointsReceived = receiveEvaluatedPoints(worldSize, nbPointsSent, pointsVector, pointState, evalpointVector);
+                // Update the surrogate and the best f with the new points only.
+                // Aborted evaluations only give a lower bound on f.
+                double newBestF = bestF;
+                double now = MPI_Wtime();
+                for (; nbPointsModeled < evalpointVector.size(); nbPointsModeled++)
+                {
+                    EvalPoint &ep = evalpointVector[nbPointsModeled];
+                    metrics.addCompleted(ep.getWorker(), now);
+                    if (ep.getEvalOk() && !ep.getAborted())
+                    {
+                        surrogate.addPoint(ep.getX(), ep.getF());
+                        if (ep.getFeasible() && ep.getF() < newBestF)
+                        {
+                            newBestF = ep.getF();
+                        }
+                    }
+                }
+                if (newBestF < bestF)
+                {
+                    bestF = newBestF;
+                    sendThresholdToWorkers(bestF, worldSize);
+                    metrics.setBestF(bestF);
+                }
+                metrics.publishIfDue(now);
+            }
         }
         // All points received, master is done.
 
@@ -177,15 +205,35 @@ int main(int argc, char** argv)
         sendEvaluationDoneToWorkers(worldSize);
         // Wait for all workers to have acknowledged they are done.
         waitAllWorkersDone(worldSize);
+        metrics.publishDone(MPI_Wtime());
 
         // Print all points.
-        std::cout << std::endl << "Summary of " << evalpointVector.size() << " evalpoints:" << std::endl;
-        std::cout << "X\tF\tProcess" << std::endl;
+        std::cout << std::endl << "Summary of " << evalpointVector.size() << " evalpoints";
+        std::cout << " (" << nbPointsSkipped << " points skipped by screening):" << std::endl;
+        std::cout << "X\tF\tProcess\tStatus" << std::endl;
         for (int i = 0; i < evalpointVector.size(); i++)
         {
             EvalPoint ep = evalpointVector[i];
-            std::cout << ep.getX() << "\t" << ep.getF() << "\t" << ep.getWorker() << std::endl;
+            std::cout << ep.getX() << "\t" << ep.getF() << "\t" << ep.getWorker() << "\t";
+            if (!ep.getEvalOk())
+            {
+                std::cout << "failed";
+            }
+            else if (!ep.getFeasible())
+            {
+                std::cout << "infeasible";
+            }
+            else if (ep.getAborted())
+            {
+                std::cout << "aborted";
+            }
+            else
+            {
+                std::cout << "ok";
+            }
+            std::cout << std::endl;
         }
+        std::cout << "Best feasible f: " << bestF << std::endl;
     }
 
     // Finalize the MPI environment.
@@ -0,0 +1,137 @@
+#include <mpi.h>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "MasterControl.hpp"
+
+// Microbenchmark of the fixed cost of the master/worker protocol per
+// evaluation, separate from the evaluator.
+//
+// The real messaging paths are used: sendPointsToWorkers,
+// receiveEvaluatedPoints, EvaluatorControl::run on workers, and the done
+// handshake. Points have x = 0, for which the mock evaluator does no work.
+//
+// Each round, master sends one point to each worker, and polls until all
+// results are received. For each point, the round completion latency is the
+// time between the start of the sends of its round and the end of the call of
+// receiveEvaluatedPoints that received it. It includes the master's serial
+// sends to all workers and its scans of all workers, so it grows with the
+// number of ranks even if the per-message overhead does not.
+//
+// Usage: mpirun -np <number of processes> bench [nb rounds]
+// Results are printed by master as a single JSON line, so that runs with
+// different numbers of processes can be compared.
+
+
+// Percentile p (between 0 and 1) of sorted values.
+double percentile(const std::vector<double> &sortedValues, const double p)
+{
+    if (sortedValues.empty())
+    {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(p * (sortedValues.size() - 1) + 0.5);
+    return sortedValues[index];
+}
+
+
+int main(int argc, char** argv)
+{
+    MPI_Init(&argc, &argv);
+
+    int worldSize;
+    MPI_Comm_size(MPI_COMM_WORLD, &worldSize);
+    int worldRank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &worldRank);
+
+    if (worldSize <= 1)
+    {
+        if (0 == worldRank)
+        {
+            std::cout << "Usage: mpirun -np <nb of processes> " << argv[0] << " [nb rounds]" << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    int nbRounds = 1000;
+    if (argc >= 2)
+    {
+        nbRounds = std::max(1, std::atoi(argv[1]));
+    }
+
+    if (0 != worldRank)
+    {
+        Evaluator evaluator;
+        EvaluatorControl evc(evaluator);
+        evc.setVerbose(false);
+        evc.run();
+    }
+    else
+    {
+        int nbWorkers = worldSize - 1;
+        size_t nbPoints = static_cast<size_t>(nbRounds) * nbWorkers;
+        std::vector<double> pointsVector(nbPoints, 0.0);
+        std::vector<PointState> pointState(nbPoints, pointNotSent);
+        std::vector<EvalPoint> evalpointVector;
+        evalpointVector.reserve(nbPoints);
+        std::vector<double> roundCompletions;
+        roundCompletions.reserve(nbPoints);
+
+        double startTime = MPI_Wtime();
+        size_t nbPointsSent = 0;
+        for (int round = 0; round < nbRounds; round++)
+        {
+            std::vector<uint64_t> pointIds;
+            for (int i = 0; i < nbWorkers; i++)
+            {
+                pointIds.push_back(nbPointsSent + i);
+            }
+            double sendTime = MPI_Wtime();
+            sendPointsToWorkers(pointsVector, pointIds, nbPointsSent, worldSize, pointState);
+            nbPointsSent += pointIds.size();
+
+            bool allPointsReceived = false;
+            while (!allPointsReceived)
+            {
+                size_t nbPointsBefore = evalpointVector.size();
+                allPointsReceived = receiveEvaluatedPoints(worldSize, nbPointsSent, pointsVector, pointState, evalpointVector);
+                double receiveTime = MPI_Wtime();
+                for (size_t i = nbPointsBefore; i < evalpointVector.size(); i++)
+                {
+                    roundCompletions.push_back(receiveTime - sendTime);
+                }
+            }
+        }
+        double evalTime = MPI_Wtime() - startTime;
+
+        double doneStartTime = MPI_Wtime();
+        sendEvaluationDoneToWorkers(worldSize);
+        waitAllWorkersDone(worldSize);
+        double doneTime = MPI_Wtime() - doneStartTime;
+
+        std::sort(roundCompletions.begin(), roundCompletions.end());
+        // Master sends one message and receives one message per point.
+        double messagesPerSecond = 2.0 * nbPointsSent / evalTime;
+
+        std::cout << "{\"ranks\": " << worldSize
+                  << ", \"workers\": " << nbWorkers
+                  << ", \"rounds\": " << nbRounds
+                  << ", \"points\": " << roundCompletions.size()
+                  << ", \"round_completion_us\": {"
+                  << "\"min\": " << 1e6 * percentile(roundCompletions, 0.0)
+                  << ", \"p50\": " << 1e6 * percentile(roundCompletions, 0.50)
+                  << ", \"p90\": " << 1e6 * percentile(roundCompletions, 0.90)
+                  << ", \"p99\": " << 1e6 * percentile(roundCompletions, 0.99)
+                  << ", \"max\": " << 1e6 * percentile(roundCompletions, 1.0)
+                  << "}"
+                  << ", \"master_messages_per_s\": " << messagesPerSecond
+                  << ", \"done_handshake_us\": " << 1e6 * doneTime
+                  << "}" << std::endl;
+    }
+
+    MPI_Finalize();
+    return 0;
+}
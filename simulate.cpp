@@ -0,0 +1,438 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "EvaluatorControl.hpp"
+
+// Discrete-event simulation of the master/worker protocol of algo, in a single
+// process and without MPI.
+//
+// The master is simulated as in algo: points are sent in batches, with
+// sendPointsToWorkers' round-robin; results are received by repeated calls to
+// receiveEvaluatedPoints, which probe all workers in rank order; then
+// sendEvaluationDoneToWorkers and waitAllWorkersDone.
+// Workers are simulated as in EvaluatorControl::run: with 1 thread, the points
+// of a message are evaluated one after the other, and each result is sent back
+// as soon as it is computed. With more threads, the main thread loops: it sends
+// all results ready in a single message, or, if there are none, waits for one
+// for up to resultWaitTimeout. Results that become ready during an iteration of the loop
+// are sent together.
+//
+// Not simulated: screening (use a smaller number of points instead), thresholds
+// and early aborts, and the time workers spend probing.
+//
+// Usage: simulate [key=value ...]. See SimParams for keys. Times are in
+// seconds, bandwidth in bytes per second.
+
+
+struct SimParams
+{
+    int         worldSize    = 1001;    // ranks: Number of ranks, including master.
+    int         nbPoints     = 10000;   // points
+    int         batchSize    = 0;       // batch: 0 for a single batch.
+    int         nbThreads    = 1;       // threads: Evaluator threads per worker.
+    double      latency      = 2e-6;    // latency
+    double      bandwidth    = 1e10;    // bandwidth
+    double      sendOverhead = 1e-6;    // send: Master CPU time per MPI_Send.
+    double      recvOverhead = 1e-6;    // recv: Master CPU time per MPI_Recv.
+    double      probeCost    = 1e-7;    // probe: Master CPU time per MPI_Iprobe.
+    double      workerLoop   = 2e-6;    // loop: Time of one iteration of the worker main loop, with threads > 1.
+    std::string evalDist     = "exp";   // eval: const, exp, lognormal or trace.
+    double      evalMean     = 1.0;     // mean
+    double      evalSigma    = 0.5;     // sigma: Of log(eval time), for lognormal.
+    std::string traceFile;              // trace: One eval time per line.
+    unsigned    seed         = 1;       // seed
+};
+
+
+// Message waiting in the master's receive queue for a given worker.
+struct SimMessage
+{
+    double  arrival;    // Time the message is available at master.
+    int     nbItems;    // Number of results in the message.
+};
+
+
+struct SimStats
+{
+    double  totalEvalTime   = 0.0;
+    double  masterSendTime  = 0.0;
+    double  masterRecvTime  = 0.0;
+    size_t  nbSent          = 0;
+    size_t  nbReceived      = 0;
+    double  sumPollDelay    = 0.0;  // Time between arrival and receive of messages.
+    double  maxPollDelay    = 0.0;
+};
+
+
+// Draw evaluation times from the distribution given in params.
+class EvalTimeSampler
+{
+private:
+    SimParams                   _params;
+    std::mt19937_64             _rng;
+    std::vector<double>         _trace;
+
+public:
+    // Constructor
+    EvalTimeSampler(const SimParams &params)
+      : _params(params),
+        _rng(params.seed)
+    {
+        if ("trace" == _params.evalDist)
+        {
+            std::ifstream in(_params.traceFile.c_str());
+            double t;
+            while (in >> t)
+            {
+                _trace.push_back(t);
+            }
+        }
+    }
+
+    // Returns: false if eval times are resampled from a trace, but none
+    // could be read.
+    bool isValid() const
+    {
+        return "trace" != _params.evalDist || !_trace.empty();
+    }
+
+    double sample()
+    {
+        if ("exp" == _params.evalDist)
+        {
+            std::exponential_distribution<double> dist(1.0 / _params.evalMean);
+            return dist(_rng);
+        }
+        if ("lognormal" == _params.evalDist)
+        {
+            // Choose mu so that the mean of the distribution is evalMean.
+            double sigma = _params.evalSigma;
+            std::lognormal_distribution<double> dist(std::log(_params.evalMean) - sigma * sigma / 2, sigma);
+            return dist(_rng);
+        }
+        if ("trace" == _params.evalDist)
+        {
+            // Resample the recorded eval times.
+            std::uniform_int_distribution<size_t> dist(0, _trace.size() - 1);
+            return _trace[dist(_rng)];
+        }
+        return _params.evalMean;
+    }
+};
+
+
+// Worker receives a message of nbPoints at time arrival, evaluates them, and
+// sends the results back to master.
+void simulateWorker(const SimParams &params, const double arrival, const int nbPoints,
+                    EvalTimeSampler &sampler, std::deque<SimMessage> &inbox, SimStats &stats)
+{
+    const double resultTransfer = sizeof(ResultMessage) / params.bandwidth;
+    if (params.nbThreads <= 1)
+    {
+        double finish = arrival;
+        for (int i = 0; i < nbPoints; i++)
+        {
+            double evalTime = sampler.sample();
+            stats.totalEvalTime += evalTime;
+            finish += evalTime;
+            SimMessage message;
+            message.arrival = finish + resultTransfer + params.latency;
+            message.nbItems = 1;
+            inbox.push_back(message);
+        }
+        return;
+    }
+
+    // Points are taken from the queue by the first free thread.
+    std::priority_queue<double, std::vector<double>, std::greater<double> > threadFree;
+    for (int i = 0; i < params.nbThreads; i++)
+    {
+        threadFree.push(arrival);
+    }
+    std::vector<double> finishes;
+    for (int i = 0; i < nbPoints; i++)
+    {
+        double evalTime = sampler.sample();
+        stats.totalEvalTime += evalTime;
+        double finish = threadFree.top() + evalTime;
+        threadFree.pop();
+        threadFree.push(finish);
+        finishes.push_back(finish);
+    }
+    std::sort(finishes.begin(), finishes.end());
+
+    // Main thread loop.
+    const double timeoutPeriod = resultWaitTimeout + params.workerLoop;
+    double loopTime = arrival;
+    size_t nbSent = 0;
+    while (nbSent < finishes.size())
+    {
+        double nextFinish = finishes[nbSent];
+        if (nextFinish > loopTime)
+        {
+            // No result ready: skip the iterations that end with a timeout,
+            // then wait until the next result is ready, or the next timeout.
+            double nbTimeouts = std::floor((nextFinish - loopTime) / timeoutPeriod);
+            loopTime += nbTimeouts * timeoutPeriod;
+            if (nextFinish <= loopTime + resultWaitTimeout)
+            {
+                loopTime = std::max(loopTime, nextFinish);
+            }
+            else
+            {
+                loopTime += timeoutPeriod;
+                continue;
+            }
+        }
+
+        // Send all results ready, in a single message.
+        int nbReady = 0;
+        while (nbSent < finishes.size() && finishes[nbSent] <= loopTime)
+        {
+            nbReady++;
+            nbSent++;
+        }
+        SimMessage message;
+        message.arrival = loopTime + nbReady * resultTransfer + params.latency;
+        message.nbItems = nbReady;
+        inbox.push_back(message);
+
+        loopTime += params.workerLoop;
+    }
+}
+
+
+// One call to receiveEvaluatedPoints (or one pass of waitAllWorkersDone):
+// probe all workers in rank order, and receive at most one message from each.
+// Only workers in pendingWorkers have messages to receive; the others only
+// cost a probe.
+// Returns: the number of items received.
+int simulateScan(const SimParams &params, double &masterTime,
+                 std::vector<std::deque<SimMessage> > &inbox, std::set<int> &pendingWorkers,
+                 SimStats &stats)
+{
+    const double scanTime = (params.worldSize - 1) * params.probeCost;
+
+    // Skip scans where nothing can be received.
+    double firstArrival = -1.0;
+    for (std::set<int>::iterator it = pendingWorkers.begin(); it != pendingWorkers.end(); ++it)
+    {
+        double arrival = inbox[*it].front().arrival;
+        if (firstArrival < 0.0 || arrival < firstArrival)
+        {
+            firstArrival = arrival;
+        }
+    }
+    if (firstArrival > masterTime + scanTime)
+    {
+        if (scanTime > 0.0)
+        {
+            masterTime += std::floor((firstArrival - masterTime) / scanTime) * scanTime;
+        }
+        else
+        {
+            masterTime = firstArrival;
+        }
+    }
+
+    int nbItems = 0;
+    int prevRank = 0;
+    std::set<int>::iterator it = pendingWorkers.begin();
+    while (it != pendingWorkers.end())
+    {
+        int workerRank = *it;
+        masterTime += (workerRank - prevRank) * params.probeCost;
+        prevRank = workerRank;
+
+        std::deque<SimMessage> &queue = inbox[workerRank];
+        if (queue.front().arrival <= masterTime)
+        {
+            double pollDelay = masterTime - queue.front().arrival;
+            stats.sumPollDelay += pollDelay;
+            stats.maxPollDelay = std::max(stats.maxPollDelay, pollDelay);
+            stats.nbReceived++;
+            stats.masterRecvTime += params.recvOverhead;
+            masterTime += params.recvOverhead;
+            nbItems += queue.front().nbItems;
+            queue.pop_front();
+        }
+
+        if (queue.empty())
+        {
+            pendingWorkers.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    masterTime += (params.worldSize - 1 - prevRank) * params.probeCost;
+
+    return nbItems;
+}
+
+
+// Master sends a message of nbBytes to a worker.
+// Returns: the time the message is available at the worker.
+double simulateMasterSend(const SimParams &params, const size_t nbBytes, double &masterTime, SimStats &stats)
+{
+    double sendTime = params.sendOverhead + nbBytes / params.bandwidth;
+    masterTime += sendTime;
+    stats.masterSendTime += sendTime;
+    stats.nbSent++;
+    return masterTime + params.latency;
+}
+
+
+bool parseArg(const std::string &arg, SimParams &params)
+{
+    size_t pos = arg.find('=');
+    if (std::string::npos == pos)
+    {
+        return false;
+    }
+    std::string key = arg.substr(0, pos);
+    std::string value = arg.substr(pos + 1);
+    if ("ranks" == key)             { params.worldSize = std::atoi(value.c_str()); }
+    else if ("points" == key)       { params.nbPoints = std::atoi(value.c_str()); }
+    else if ("batch" == key)        { params.batchSize = std::atoi(value.c_str()); }
+    else if ("threads" == key)      { params.nbThreads = std::atoi(value.c_str()); }
+    else if ("latency" == key)      { params.latency = std::atof(value.c_str()); }
+    else if ("bandwidth" == key)    { params.bandwidth = std::atof(value.c_str()); }
+    else if ("send" == key)         { params.sendOverhead = std::atof(value.c_str()); }
+    else if ("recv" == key)         { params.recvOverhead = std::atof(value.c_str()); }
+    else if ("probe" == key)        { params.probeCost = std::atof(value.c_str()); }
+    else if ("loop" == key)         { params.workerLoop = std::atof(value.c_str()); }
+    else if ("eval" == key)
+    {
+        if ("const" != value && "exp" != value && "lognormal" != value && "trace" != value)
+        {
+            return false;
+        }
+        params.evalDist = value;
+    }
+    else if ("mean" == key)         { params.evalMean = std::atof(value.c_str()); }
+    else if ("sigma" == key)        { params.evalSigma = std::atof(value.c_str()); }
+    else if ("trace" == key)        { params.traceFile = value; params.evalDist = "trace"; }
+    else if ("seed" == key)         { params.seed = std::atoi(value.c_str()); }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+
+int main(int argc, char** argv)
+{
+    SimParams params;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!parseArg(argv[i], params))
+        {
+            std::cout << "Usage: " << argv[0] << " [ranks=N] [points=N] [batch=N] [threads=N]"
+                      << " [latency=s] [bandwidth=B/s] [send=s] [recv=s] [probe=s] [loop=s]"
+                      << " [eval=const|exp|lognormal|trace] [mean=s] [sigma=x] [trace=file] [seed=N]" << std::endl;
+            return 1;
+        }
+    }
+    if (params.worldSize <= 1 || params.nbPoints <= 0 || params.nbThreads < 1 || params.bandwidth <= 0.0)
+    {
+        std::cout << "Need ranks > 1, points > 0, threads > 0 and bandwidth > 0." << std::endl;
+        return 1;
+    }
+    if (!(params.evalMean > 0.0) || !(params.evalSigma >= 0.0))
+    {
+        std::cout << "Need mean > 0 and sigma >= 0." << std::endl;
+        return 1;
+    }
+    if (!(params.latency >= 0.0) || !(params.sendOverhead >= 0.0) || !(params.recvOverhead >= 0.0)
+        || !(params.probeCost >= 0.0) || !(params.workerLoop >= 0.0))
+    {
+        std::cout << "Need latency, send, recv, probe and loop >= 0." << std::endl;
+        return 1;
+    }
+    int batchSize = (params.batchSize > 0) ? params.batchSize : params.nbPoints;
+    int nbWorkers = params.worldSize - 1;
+
+    EvalTimeSampler sampler(params);
+    if (!sampler.isValid())
+    {
+        std::cout << "No eval time could be read from trace file \"" << params.traceFile << "\"." << std::endl;
+        return 1;
+    }
+    SimStats stats;
+    double masterTime = 0.0;
+    std::vector<std::deque<SimMessage> > inbox(params.worldSize);
+    std::set<int> pendingWorkers;
+
+    for (int batchStart = 0; batchStart < params.nbPoints; batchStart += batchSize)
+    {
+        int nbBatchPoints = std::min(batchSize, params.nbPoints - batchStart);
+
+        // sendPointsToWorkers: one message per worker that gets points.
+        std::vector<int> nbPointsPerWorker(params.worldSize, 0);
+        for (int pointIndex = 0; pointIndex < nbBatchPoints; pointIndex++)
+        {
+            nbPointsPerWorker[roundRobinWorkerRank(batchStart + pointIndex, params.worldSize)]++;
+        }
+        for (int workerRank = 1; workerRank < params.worldSize; workerRank++)
+        {
+            int nbWorkerPoints = nbPointsPerWorker[workerRank];
+            if (nbWorkerPoints > 0)
+            {
+                double arrival = simulateMasterSend(params, nbWorkerPoints * sizeof(PointMessage), masterTime, stats);
+                simulateWorker(params, arrival, nbWorkerPoints, sampler, inbox[workerRank], stats);
+                pendingWorkers.insert(workerRank);
+            }
+        }
+
+        // receiveEvaluatedPoints until all points of the batch are received.
+        int nbReceived = 0;
+        while (nbReceived < nbBatchPoints)
+        {
+            nbReceived += simulateScan(params, masterTime, inbox, pendingWorkers, stats);
+        }
+    }
+    double lastResultTime = masterTime;
+
+    // sendEvaluationDoneToWorkers, and waitAllWorkersDone.
+    for (int workerRank = 1; workerRank < params.worldSize; workerRank++)
+    {
+        double arrival = simulateMasterSend(params, sizeof(int), masterTime, stats);
+        SimMessage message;
+        message.arrival = arrival + sizeof(int) / params.bandwidth + params.latency;
+        message.nbItems = 1;
+        inbox[workerRank].push_back(message);
+        pendingWorkers.insert(workerRank);
+    }
+    int nbWorkersDone = 0;
+    while (nbWorkersDone < nbWorkers)
+    {
+        nbWorkersDone += simulateScan(params, masterTime, inbox, pendingWorkers, stats);
+    }
+    double makespan = masterTime;
+
+    std::cout << "Ranks: " << params.worldSize << ", threads per worker: " << params.nbThreads
+              << ", points: " << params.nbPoints << ", batch size: " << batchSize << std::endl;
+    std::cout << "Makespan: " << makespan << " s" << std::endl;
+    std::cout << "Time of last result: " << lastResultTime << " s" << std::endl;
+    std::cout << "Shutdown time: " << makespan - lastResultTime << " s" << std::endl;
+    std::cout << "Worker utilization: " << stats.totalEvalTime / (makespan * nbWorkers * params.nbThreads) << std::endl;
+    std::cout << "Master send/recv busy fraction: " << (stats.masterSendTime + stats.masterRecvTime) / makespan << std::endl;
+    std::cout << "Master messages/s: " << (stats.nbSent + stats.nbReceived) / makespan << std::endl;
+    std::cout << "Mean poll delay: " << stats.sumPollDelay / stats.nbReceived << " s" << std::endl;
+    std::cout << "Max poll delay: " << stats.maxPollDelay << " s" << std::endl;
+
+    return 0;
+}